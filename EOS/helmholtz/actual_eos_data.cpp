@@ -10,16 +10,19 @@ AMREX_GPU_MANAGED amrex::Real helmholtz::ttol;
 AMREX_GPU_MANAGED amrex::Real helmholtz::dtol;
 
 // for the helmholtz free energy tables
-AMREX_GPU_MANAGED amrex::Real helmholtz::f[jmax][imax][9];
+AMREX_GPU_MANAGED amrex::Real (*helmholtz::f)[imax][nf];
 
 // for the pressure derivative with density tables
-AMREX_GPU_MANAGED amrex::Real helmholtz::dpdf[jmax][imax][4];
+AMREX_GPU_MANAGED amrex::Real (*helmholtz::dpdf)[imax][ndpdf];
 
 // for chemical potential tables
-AMREX_GPU_MANAGED amrex::Real helmholtz::ef[jmax][imax][4];
+AMREX_GPU_MANAGED amrex::Real (*helmholtz::ef)[imax][nef];
 
 // for the number density tables
-AMREX_GPU_MANAGED amrex::Real helmholtz::xf[jmax][imax][4];
+AMREX_GPU_MANAGED amrex::Real (*helmholtz::xf)[imax][nxf];
+
+// the cell-blocked table
+AMREX_GPU_MANAGED amrex::Real* helmholtz::cells;
 
 // for storing the differences
 AMREX_GPU_MANAGED amrex::Real helmholtz::dt_sav[jmax];
@@ -31,3 +34,8 @@ AMREX_GPU_MANAGED amrex::Real helmholtz::dd_sav[imax];
 AMREX_GPU_MANAGED amrex::Real helmholtz::dd2_sav[imax];
 AMREX_GPU_MANAGED amrex::Real helmholtz::ddi_sav[imax];
 AMREX_GPU_MANAGED amrex::Real helmholtz::dd2i_sav[imax];
+
+AMREX_GPU_MANAGED int helmholtz::inverse::ready{};
+AMREX_GPU_MANAGED amrex::Real* helmholtz::inverse::cold[helmholtz::inverse::ntables]{};
+AMREX_GPU_MANAGED amrex::Real* helmholtz::inverse::range[helmholtz::inverse::ntables]{};
+AMREX_GPU_MANAGED amrex::Real* helmholtz::inverse::data[helmholtz::inverse::ntables]{};
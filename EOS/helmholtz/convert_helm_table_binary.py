@@ -0,0 +1,67 @@
+# Read in the Helmholtz EOS table and write it in the binary format
+# that the C++ EOS can map directly into memory (see helm_table.cpp).
+#
+# The output is a 64-byte header followed by the four tables (free
+# energy, pressure derivative, electron chemical potential, and number
+# density) as doubles, in the order and with the column permutation
+# that actual_eos_data.H uses in memory.  The file is written in the
+# native byte order of the machine running this script.
+#
+# usage: python convert_helm_table_binary.py [helm_table.dat [helm_table.bin]]
+
+import struct
+import sys
+from array import array
+
+# Number of density rows
+imax = 541
+
+# Number of temperature columns
+jmax = 201
+
+# log10 of the temperature and density limits
+tlo = 3.0
+thi = 13.0
+dlo = -12.0
+dhi = 15.0
+
+version = 1
+byte_order = 0x01020304
+
+# for each table, the number of columns and where each column of the
+# text file goes in memory
+
+tables = [("free energy", [0, 3, 1, 4, 2, 5, 6, 7, 8]),
+          ("pressure derivative", [0, 2, 1, 3]),
+          ("electron chemical potential", [0, 2, 1, 3]),
+          ("number density", [0, 2, 1, 3])]
+
+table_name = sys.argv[1] if len(sys.argv) > 1 else 'helm_table.dat'
+out_name = sys.argv[2] if len(sys.argv) > 2 else 'helm_table.bin'
+
+data = array('d')
+nvars = 0
+
+with open(table_name, 'r') as table:
+    for name, perm in tables:
+        nvar = len(perm)
+        nvars += nvar
+        for _ in range(imax * jmax):
+            line = table.readline().split()
+            if len(line) < nvar:
+                sys.exit(f"error reading the {name} table from {table_name}")
+            vals = [0.0] * nvar
+            for m in range(nvar):
+                vals[perm[m]] = float(line[m].replace('D', 'e').replace('d', 'e'))
+            data.extend(vals)
+
+header = struct.pack('=8siiiiddddii', b'HELMTAB\0', version, byte_order,
+                     imax, jmax, tlo, thi, dlo, dhi, nvars, 0)
+
+assert len(header) == 64
+
+with open(out_name, 'wb') as out:
+    out.write(header)
+    data.tofile(out)
+
+print(f"wrote {out_name}")
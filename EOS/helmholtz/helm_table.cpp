@@ -0,0 +1,595 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <AMReX.H>
+#include <AMReX_REAL.H>
+#include <AMReX_Arena.H>
+#include <AMReX_Print.H>
+#include <AMReX_GpuContainers.H>
+#include <AMReX_ParallelDescriptor.H>
+
+#ifdef AMREX_USE_MPI
+#include <mpi.h>
+#endif
+
+#include <extern_parameters.H>
+#include <actual_eos_data.H>
+
+// Reading the Helmholtz tables.
+//
+// The text table (helm_table.dat) is parsed on the I/O processor and
+// broadcast.  The binary table (written by
+// convert_helm_table_binary.py) is simply mapped into memory by every
+// rank, so there is no parsing and the operating system's page cache
+// holds a single copy per node.  On CPUs, we point directly at the
+// mapping.
+//
+// With eos.helm_table_node_shared = 1 (CPU builds with MPI), the
+// tables instead live in an MPI-3 shared memory window, filled once
+// per node and read by all of the ranks on the node.
+//
+// With eos.helm_table_blocked = 1, we also build the cell-blocked
+// table (see actual_eos_data.H) from the host copy of the tables.
+// With the node-shared table, this goes in the same window, after
+// the tables.
+
+namespace
+{
+    using namespace amrex::literals;
+
+    enum class storage_t {none, arena, mapped, shared_window};
+
+    storage_t storage = storage_t::none;
+
+    amrex::Real* table_data = nullptr;
+
+    // the binary file mapping, when we point directly into it
+    void* map_addr = nullptr;
+    size_t map_length = 0;
+
+    // the allocation holding the (aligned) cell-blocked table
+    void* cells_alloc = nullptr;
+
+#ifdef AMREX_USE_MPI
+    MPI_Win table_win = MPI_WIN_NULL;
+    MPI_Comm node_comm = MPI_COMM_NULL;
+#endif
+
+    constexpr size_t block_size = static_cast<size_t>(helmholtz::imax) * helmholtz::jmax;
+
+    bool is_binary_table (const std::string& name)
+    {
+        std::ifstream table(name, std::ios::binary);
+
+        if (!table.is_open()) {
+            amrex::Error(name + " could not be opened");
+        }
+
+        char magic[sizeof(helmholtz::table_magic)] = {};
+        table.read(magic, sizeof(magic));
+
+        return table.gcount() == sizeof(magic) &&
+               std::memcmp(magic, helmholtz::table_magic, sizeof(magic)) == 0;
+    }
+
+    // read one of the four tables from the text file, where perm
+    // gives the position in our storage of each column in the file
+
+    template <int nvar>
+    void read_text_block (std::ifstream& table, amrex::Real* dest,
+                          const int (&perm)[nvar], const std::string& what)
+    {
+        std::string line;
+
+        for (size_t n = 0; n < block_size; ++n) {
+            std::getline(table, line);
+            if (line.empty()) {
+                amrex::Error("Error reading " + what + " from " + eos_rp::helm_table_name);
+            }
+            std::istringstream data(line);
+            for (int m = 0; m < nvar; ++m) {
+                data >> dest[n * nvar + perm[m]];
+            }
+        }
+    }
+
+    void read_text_table (amrex::Real* dest)
+    {
+        using namespace helmholtz;
+
+        std::ifstream table(eos_rp::helm_table_name);
+
+        if (!table.is_open()) {
+            amrex::Error(eos_rp::helm_table_name + " could not be opened");
+        }
+
+        constexpr int perm_f[nf] = {0, 3, 1, 4, 2, 5, 6, 7, 8};
+        constexpr int perm_4[4] = {0, 2, 1, 3};
+
+        read_text_block<nf>(table, dest, perm_f, "free energy");
+        dest += nf * block_size;
+
+        read_text_block<ndpdf>(table, dest, perm_4, "pressure derivative");
+        dest += ndpdf * block_size;
+
+        read_text_block<nef>(table, dest, perm_4, "electron chemical potential");
+        dest += nef * block_size;
+
+        read_text_block<nxf>(table, dest, perm_4, "number density");
+    }
+
+    // map the binary table and check that it matches the grid we
+    // were compiled with.  The caller must munmap() the result.
+
+    const double* map_binary_table (void*& addr, size_t& length)
+    {
+        using namespace helmholtz;
+
+        const std::string& name = eos_rp::helm_table_name;
+
+        int fd = open(name.c_str(), O_RDONLY);
+        if (fd < 0) {
+            amrex::Error(name + " could not be opened");
+        }
+
+        struct stat sb;
+        if (fstat(fd, &sb) != 0) {
+            close(fd);
+            amrex::Error(name + " could not be read");
+        }
+
+        length = static_cast<size_t>(sb.st_size);
+
+        if (length != sizeof(table_header_t) + table_size * sizeof(double)) {
+            close(fd);
+            amrex::Error(name + " has the wrong size for a binary Helmholtz table");
+        }
+
+        addr = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (addr == MAP_FAILED) {
+            amrex::Error(name + " could not be mapped");
+        }
+
+        table_header_t header;
+        std::memcpy(&header, addr, sizeof(header));
+
+        if (std::memcmp(header.magic, table_magic, sizeof(table_magic)) != 0) {
+            amrex::Error(name + " is not a binary Helmholtz table");
+        }
+        if (header.byte_order != table_byte_order) {
+            amrex::Error(name + " was written on a machine with a different byte order");
+        }
+        if (header.version != table_version) {
+            amrex::Error(name + " has an unsupported version -- rerun convert_helm_table_binary.py");
+        }
+
+        constexpr double tol = 1.e-12;
+
+        if (header.imax != imax || header.jmax != jmax || header.nvars != nf + ndpdf + nef + nxf ||
+            std::abs(header.tlo - tlo) > tol || std::abs(header.thi - thi) > tol ||
+            std::abs(header.dlo - dlo) > tol || std::abs(header.dhi - dhi) > tol) {
+            amrex::Error(name + " does not match the table dimensions of the Helmholtz EOS");
+        }
+
+        return reinterpret_cast<const double*>(static_cast<const char*>(addr) + sizeof(table_header_t));
+    }
+
+    void read_binary_table (amrex::Real* dest)
+    {
+        void* addr = nullptr;
+        size_t length = 0;
+
+        const double* data = map_binary_table(addr, length);
+
+        for (size_t n = 0; n < helmholtz::table_size; ++n) {
+            dest[n] = static_cast<amrex::Real>(data[n]);
+        }
+
+        munmap(addr, length);
+    }
+
+    void set_table_pointers ()
+    {
+        using namespace helmholtz;
+
+        amrex::Real* p = table_data;
+
+        f = reinterpret_cast<amrex::Real (*)[imax][nf]>(p);
+        p += nf * block_size;
+
+        dpdf = reinterpret_cast<amrex::Real (*)[imax][ndpdf]>(p);
+        p += ndpdf * block_size;
+
+        ef = reinterpret_cast<amrex::Real (*)[imax][nef]>(p);
+        p += nef * block_size;
+
+        xf = reinterpret_cast<amrex::Real (*)[imax][nxf]>(p);
+    }
+
+    // the coefficients of the quintic hermite basis functions psi0,
+    // psi1, and psi2 and the cubic ones xpsi0 and xpsi1 (see
+    // actual_eos.H), in powers of z
+
+    constexpr amrex::Real psi_coeffs[3][6] = {{1.0_rt, 0.0_rt, 0.0_rt, -10.0_rt, 15.0_rt, -6.0_rt},
+                                              {0.0_rt, 1.0_rt, 0.0_rt, -6.0_rt, 8.0_rt, -3.0_rt},
+                                              {0.0_rt, 0.0_rt, 0.5_rt, -1.5_rt, 1.5_rt, -0.5_rt}};
+
+    constexpr amrex::Real xpsi_coeffs[2][4] = {{1.0_rt, 0.0_rt, -3.0_rt, 2.0_rt},
+                                               {0.0_rt, 1.0_rt, -2.0_rt, 1.0_rt}};
+
+    // the coefficients of p(1 - z) in powers of z
+
+    template <int n>
+    void reflect (const amrex::Real (&c)[n], amrex::Real (&r)[n])
+    {
+        for (int m = 0; m < n; ++m) {
+            r[m] = 0.0_rt;
+        }
+
+        for (int k = 0; k < n; ++k) {
+            amrex::Real binom = 1.0_rt;
+            for (int m = 0; m <= k; ++m) {
+                r[m] += (m % 2 == 0 ? binom : -binom) * c[k];
+                binom = binom * (k - m) / (m + 1);
+            }
+        }
+    }
+
+    // the interpolation basis functions across a cell of width h, in
+    // the order of sit and sid in interp_tables()
+
+    void quintic_basis (const amrex::Real h, amrex::Real (&b)[6][6])
+    {
+        amrex::Real r[3][6];
+        for (int n = 0; n < 3; ++n) {
+            reflect(psi_coeffs[n], r[n]);
+        }
+
+        for (int p = 0; p < 6; ++p) {
+            b[0][p] = psi_coeffs[0][p];
+            b[1][p] = psi_coeffs[1][p] * h;
+            b[2][p] = psi_coeffs[2][p] * h * h;
+            b[3][p] = r[0][p];
+            b[4][p] = -r[1][p] * h;
+            b[5][p] = r[2][p] * h * h;
+        }
+    }
+
+    void cubic_basis (const amrex::Real h, amrex::Real (&b)[4][4])
+    {
+        amrex::Real r[2][4];
+        for (int n = 0; n < 2; ++n) {
+            reflect(xpsi_coeffs[n], r[n]);
+        }
+
+        for (int p = 0; p < 4; ++p) {
+            b[0][p] = xpsi_coeffs[0][p];
+            b[1][p] = xpsi_coeffs[1][p] * h;
+            b[2][p] = r[0][p];
+            b[3][p] = -r[1][p] * h;
+        }
+    }
+
+    // Build the cell-blocked table in dest (host accessible, with room
+    // for cell_table_size values) from the tables in host memory (laid
+    // out as in the binary file).  In interp_tables(), the free
+    // energy is sum_ab fi[fi_index[b][a]] sit[a] sid[b] (see fwt()),
+    // and each bicubic table is sum_ab fi[a + 4 b] sit[a] sid[b], so
+    // expanding the basis functions in powers of xt and xd gives the
+    // coefficients.
+
+    void build_cell_table (const amrex::Real* table, amrex::Real* dest)
+    {
+        using namespace helmholtz;
+
+        constexpr int fi_index[6][6] = {{ 0,  1,  2, 18, 19, 20},
+                                        { 3,  5,  7, 21, 23, 25},
+                                        { 4,  6,  8, 22, 24, 26},
+                                        { 9, 10, 11, 27, 28, 29},
+                                        {12, 14, 16, 30, 32, 34},
+                                        {13, 15, 17, 31, 33, 35}};
+
+        // where the 4 values at each corner -- (jat, iat), (jat, iat+1),
+        // (jat+1, iat), (jat+1, iat+1) -- go in the bicubic fi
+
+        constexpr int cubic_index[4][4] = {{ 0,  1,  4,  5},
+                                           { 8,  9, 12, 13},
+                                           { 2,  3,  6,  7},
+                                           {10, 11, 14, 15}};
+
+        const amrex::Real* cubic_tables[3] = {table + nf * block_size,
+                                              table + (nf + ndpdf) * block_size,
+                                              table + (nf + ndpdf + nef) * block_size};
+        constexpr int cubic_off[3] = {cell_dpdf_off, cell_ef_off, cell_xf_off};
+
+        // zero the padding at the end of each cell
+
+        std::fill(dest, dest + cell_table_size, 0.0_rt);
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int j = 0; j < jmax-1; ++j) {
+
+            amrex::Real bt[6][6];
+            quintic_basis(t[j+1] - t[j], bt);
+
+            amrex::Real ct[4][4];
+            cubic_basis(t[j+1] - t[j], ct);
+
+            for (int i = 0; i < imax-1; ++i) {
+
+                amrex::Real bd[6][6];
+                quintic_basis(d[i+1] - d[i], bd);
+
+                amrex::Real cd[4][4];
+                cubic_basis(d[i+1] - d[i], cd);
+
+                const size_t corner[4] = {static_cast<size_t>(j) * imax + i,
+                                          static_cast<size_t>(j) * imax + i + 1,
+                                          static_cast<size_t>(j + 1) * imax + i,
+                                          static_cast<size_t>(j + 1) * imax + i + 1};
+
+                amrex::Real* c = dest + (static_cast<size_t>(j) * (imax-1) + i) * cell_stride;
+
+                // the free energy
+
+                amrex::Real fi[36];
+                for (int n = 0; n < 4; ++n) {
+                    for (int k = 0; k < nf; ++k) {
+                        fi[k + nf * n] = table[corner[n] * nf + k];
+                    }
+                }
+
+                for (int q = 0; q < 6; ++q) {
+                    for (int p = 0; p < 6; ++p) {
+                        amrex::Real sum = 0.0_rt;
+                        for (int b = 0; b < 6; ++b) {
+                            for (int a = 0; a < 6; ++a) {
+                                sum += fi[fi_index[b][a]] * bt[a][p] * bd[b][q];
+                            }
+                        }
+                        c[cell_f_off + 6 * q + p] = sum;
+                    }
+                }
+
+                // the bicubic tables
+
+                for (int m = 0; m < 3; ++m) {
+                    amrex::Real fc[16];
+                    for (int n = 0; n < 4; ++n) {
+                        for (int k = 0; k < 4; ++k) {
+                            fc[cubic_index[n][k]] = cubic_tables[m][corner[n] * 4 + k];
+                        }
+                    }
+
+                    for (int q = 0; q < 4; ++q) {
+                        for (int p = 0; p < 4; ++p) {
+                            amrex::Real sum = 0.0_rt;
+                            for (int b = 0; b < 4; ++b) {
+                                for (int a = 0; a < 4; ++a) {
+                                    sum += fc[a + 4 * b] * ct[a][p] * cd[b][q];
+                                }
+                            }
+                            c[cubic_off[m] + 4 * q + p] = sum;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // the cells are aligned to cache lines
+
+    constexpr size_t cell_align = 64;
+
+    // set the table pointers, and build the cell-blocked table in
+    // managed memory if requested (the node-shared window already
+    // holds it)
+
+    void finish_loading (const amrex::Real* host_table)
+    {
+        using namespace helmholtz;
+
+        set_table_pointers();
+
+        if (eos_rp::helm_table_blocked && storage != storage_t::shared_window) {
+            cells_alloc = amrex::The_Managed_Arena()->alloc(cell_table_size * sizeof(amrex::Real) + cell_align);
+            auto addr = reinterpret_cast<std::uintptr_t>(cells_alloc);
+            cells = reinterpret_cast<amrex::Real*>((addr + cell_align - 1) / cell_align * cell_align);
+
+            build_cell_table(host_table, cells);
+        }
+    }
+
+#if defined(AMREX_USE_MPI) && !defined(AMREX_USE_GPU)
+    void load_node_shared (bool binary)
+    {
+        using namespace helmholtz;
+
+        MPI_Comm world = amrex::ParallelDescriptor::Communicator();
+
+        MPI_Comm_split_type(world, MPI_COMM_TYPE_SHARED,
+                            amrex::ParallelDescriptor::MyProc(), MPI_INFO_NULL, &node_comm);
+
+        int node_rank;
+        MPI_Comm_rank(node_comm, &node_rank);
+
+        // only the first rank on the node provides memory.  The
+        // cell-blocked table follows the tables, with room to start it
+        // on a cache line.
+
+        size_t window_bytes = table_size * sizeof(amrex::Real);
+        if (eos_rp::helm_table_blocked) {
+            window_bytes += cell_table_size * sizeof(amrex::Real) + cell_align;
+        }
+
+        const MPI_Aint size = (node_rank == 0) ? static_cast<MPI_Aint>(window_bytes) : 0;
+
+        amrex::Real* base = nullptr;
+        MPI_Win_allocate_shared(size, sizeof(amrex::Real), MPI_INFO_NULL,
+                                node_comm, &base, &table_win);
+
+        MPI_Aint qsize;
+        int disp_unit;
+        MPI_Win_shared_query(table_win, 0, &qsize, &disp_unit, &table_data);
+
+        if (eos_rp::helm_table_blocked) {
+            // the window may be mapped at a different address on each
+            // rank, so the first rank decides where the cells start
+
+            long long cells_offset = 0;
+            if (node_rank == 0) {
+                auto addr = reinterpret_cast<std::uintptr_t>(table_data + table_size);
+                cells_offset = static_cast<long long>((addr + cell_align - 1) / cell_align * cell_align -
+                                                      reinterpret_cast<std::uintptr_t>(table_data));
+            }
+            MPI_Bcast(&cells_offset, 1, MPI_LONG_LONG, 0, node_comm);
+
+            cells = reinterpret_cast<amrex::Real*>(reinterpret_cast<char*>(table_data) + cells_offset);
+        }
+
+        MPI_Win_fence(0, table_win);
+
+        // the first rank on each node fills the window.  For the text
+        // table, only the I/O processor parses it, so we broadcast
+        // among the node leaders.
+
+        MPI_Comm leader_comm;
+        MPI_Comm_split(world, node_rank == 0 ? 0 : MPI_UNDEFINED,
+                       amrex::ParallelDescriptor::MyProc(), &leader_comm);
+
+        if (node_rank == 0) {
+            if (binary) {
+                read_binary_table(table_data);
+            } else {
+                if (amrex::ParallelDescriptor::IOProcessor()) {
+                    read_text_table(table_data);
+                }
+                MPI_Bcast(table_data, static_cast<int>(table_size),
+                          amrex::ParallelDescriptor::Mpi_typemap<amrex::Real>::type(),
+                          0, leader_comm);
+            }
+            MPI_Comm_free(&leader_comm);
+
+            if (eos_rp::helm_table_blocked) {
+                build_cell_table(table_data, cells);
+            }
+        }
+
+        MPI_Win_fence(0, table_win);
+
+        storage = storage_t::shared_window;
+    }
+#endif
+}
+
+void helmholtz::load_helm_table ()
+{
+    // decide on the format once, on the I/O processor
+
+    int binary = 0;
+    if (amrex::ParallelDescriptor::IOProcessor()) {
+        binary = is_binary_table(eos_rp::helm_table_name) ? 1 : 0;
+        if (eos_rp::helm_table_verbose) {
+            amrex::Print() << "reading the Helmholtz table from " << eos_rp::helm_table_name
+                           << (binary ? " (binary)" : " (text)") << std::endl;
+        }
+    }
+    amrex::ParallelDescriptor::Bcast(&binary, 1);
+
+    if (eos_rp::helm_table_node_shared) {
+#if defined(AMREX_USE_MPI) && !defined(AMREX_USE_GPU)
+        load_node_shared(binary);
+        finish_loading(table_data);
+        return;
+#else
+        amrex::Print() << "eos.helm_table_node_shared requires a CPU build with MPI; ignoring" << std::endl;
+#endif
+    }
+
+#ifndef AMREX_USE_GPU
+    // on CPUs, we can use the mapped file directly
+
+    if (binary && std::is_same_v<amrex::Real, double>) {
+        const double* data = map_binary_table(map_addr, map_length);
+        table_data = const_cast<amrex::Real*>(reinterpret_cast<const amrex::Real*>(data));
+        storage = storage_t::mapped;
+        finish_loading(table_data);
+        return;
+    }
+#endif
+
+    // it does not work on all machines (for GPUs) to broadcast to
+    // other procs from managed memory.  So instead we'll read into a
+    // local buffer, broadcast that (for the text table), and then copy
+    // that into managed memory (the EOS is called on the host as well
+    // as on the device)
+
+    std::vector<amrex::Real> table_local(table_size);
+
+    if (binary) {
+        read_binary_table(table_local.data());
+    } else {
+        if (amrex::ParallelDescriptor::IOProcessor()) {
+            read_text_table(table_local.data());
+        }
+        amrex::ParallelDescriptor::Bcast(table_local.data(), table_size);
+    }
+
+    table_data = static_cast<amrex::Real*>(amrex::The_Managed_Arena()->alloc(table_size * sizeof(amrex::Real)));
+    amrex::Gpu::copyAsync(amrex::Gpu::hostToDevice, table_local.begin(), table_local.end(), table_data);
+    amrex::Gpu::streamSynchronize();
+
+    storage = storage_t::arena;
+    finish_loading(table_local.data());
+}
+
+void helmholtz::free_helm_table ()
+{
+    switch (storage) {
+    case storage_t::arena:
+        amrex::The_Managed_Arena()->free(table_data);
+        break;
+    case storage_t::mapped:
+        munmap(map_addr, map_length);
+        map_addr = nullptr;
+        break;
+    case storage_t::shared_window:
+#ifdef AMREX_USE_MPI
+        MPI_Win_free(&table_win);
+        MPI_Comm_free(&node_comm);
+#endif
+        break;
+    case storage_t::none:
+        break;
+    }
+
+    storage = storage_t::none;
+    table_data = nullptr;
+
+    if (cells_alloc != nullptr) {
+        amrex::The_Managed_Arena()->free(cells_alloc);
+        cells_alloc = nullptr;
+    }
+    cells = nullptr;
+
+    f = nullptr;
+    dpdf = nullptr;
+    ef = nullptr;
+    xf = nullptr;
+}
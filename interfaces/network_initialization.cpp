@@ -1,4 +1,7 @@
 #ifdef REACTIONS
+#include <AMReX.H>
+#include <extern_parameters.H>
+#include <reaclib_tables_data.H>
 #include <actual_network.H>
 #ifdef NEW_NETWORK_IMPLEMENTATION
 #include <rhs.H>
@@ -11,6 +14,12 @@
 #ifdef NSE_NET
 #include <nse_solver.H>
 #endif
+
+// the flux RHS is selected by hooks that were added by hand to the
+// generated actual_rhs.H, so make sure this network still has them
+#if defined(REACT_FLUX_RHS) && !defined(FLUX_RHS_H)
+#error "USE_REACT_FLUX_RHS=TRUE, but this network's actual_rhs.H does not use flux_rhs.H"
+#endif
 #endif
 
 void network_init()
@@ -28,6 +37,14 @@ nonaka_init();
     actual_rhs_init();
 #endif
 
+    // the rate tables are set up by a call to init_reaclib_tables()
+    // that was added by hand to the pynucastro networks, so a network
+    // without it (or one that was regenerated) would ignore the option
+
+    if (network_rp::use_reaclib_tables && reaclib_tables::ntab == 0) {
+        amrex::Error("network.use_reaclib_tables = 1, but this network does not use the tabulated ReacLib rates");
+    }
+
 #endif
 
 }
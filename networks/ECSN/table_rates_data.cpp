@@ -71,5 +71,17 @@ void init_tabular()
     init_tab_info(j_F20_Ne20_meta, "20f-20ne_betadecay.dat", j_F20_Ne20_rhoy, j_F20_Ne20_temp, j_F20_Ne20_data);
 
 
+    if (network_rp::use_packed_rate_tables) {
+
+        packed_rate_table_builder_t builder;
+
+        builder.add(j_F20_O20_meta, j_F20_O20_rhoy, j_F20_O20_temp, j_F20_O20_data);
+        builder.add(j_Ne20_F20_meta, j_Ne20_F20_rhoy, j_Ne20_F20_temp, j_Ne20_F20_data);
+        builder.add(j_O20_F20_meta, j_O20_F20_rhoy, j_O20_F20_temp, j_O20_F20_data);
+        builder.add(j_F20_Ne20_meta, j_F20_Ne20_rhoy, j_F20_Ne20_temp, j_F20_Ne20_data);
+
+        builder.finalize();
+
+    }
 
 }
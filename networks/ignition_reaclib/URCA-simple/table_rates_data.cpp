@@ -71,5 +71,17 @@ void init_tabular()
     init_tab_info(j_p_n_meta, "p-n_electroncapture.dat", j_p_n_rhoy, j_p_n_temp, j_p_n_data);
 
 
+    if (network_rp::use_packed_rate_tables) {
+
+        packed_rate_table_builder_t builder;
+
+        builder.add(j_Na23_Ne23_meta, j_Na23_Ne23_rhoy, j_Na23_Ne23_temp, j_Na23_Ne23_data);
+        builder.add(j_Ne23_Na23_meta, j_Ne23_Na23_rhoy, j_Ne23_Na23_temp, j_Ne23_Na23_data);
+        builder.add(j_n_p_meta, j_n_p_rhoy, j_n_p_temp, j_n_p_data);
+        builder.add(j_p_n_meta, j_p_n_rhoy, j_p_n_temp, j_p_n_data);
+
+        builder.finalize();
+
+    }
 
 }
@@ -0,0 +1,5 @@
+#include <packed_rate_tables_data.H>
+
+AMREX_GPU_MANAGED int packed_rate_tables::ngrids{};
+AMREX_GPU_MANAGED int packed_rate_tables::ntables{};
+AMREX_GPU_MANAGED packed_rate_tables::grid_t packed_rate_tables::grids[packed_rate_tables::max_grids]{};
@@ -0,0 +1,14 @@
+#include <reaclib_tables_data.H>
+
+AMREX_GPU_MANAGED int reaclib_tables::ntab{};
+AMREX_GPU_MANAGED int reaclib_tables::nrates{};
+
+AMREX_GPU_MANAGED amrex::Real reaclib_tables::T_lo{};
+AMREX_GPU_MANAGED amrex::Real reaclib_tables::T_hi{};
+
+AMREX_GPU_MANAGED amrex::Real reaclib_tables::lnT_lo{};
+AMREX_GPU_MANAGED amrex::Real reaclib_tables::dlnT{};
+AMREX_GPU_MANAGED amrex::Real reaclib_tables::dlnT_inv{};
+
+AMREX_GPU_MANAGED int* reaclib_tables::rate_index{};
+AMREX_GPU_MANAGED amrex::Real* reaclib_tables::data{};
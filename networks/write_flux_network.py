@@ -0,0 +1,296 @@
+#!/usr/bin/env python3
+
+"""Write the reaction fluxes of a pynucastro network and the
+stoichiometry that connects them to the species, so that the RHS and
+Jacobian can be assembled from a flux vector (see flux_rhs.H), to
+flux_network.H.
+
+The generated rhs_nuc() in the network's actual_rhs.H writes out each
+term of dY_i/dt in full, e.g.
+
+    -0.5*screened_rates(k_He4_He4_He4_to_C12)*amrex::Math::powi<3>(Y(He4))*amrex::Math::powi<2>(state.rho)
+
+We parse every term into a numeric coefficient and a flux -- the
+screened rate times a monomial in the molar abundances, density, and
+Y_e.  A flux that appears in several species' equations is stored
+once, with a coefficient for each of those species.  The Jacobian
+then follows from the derivatives of each flux with respect to its
+reactants, so jac_nuc() does not need to be parsed, but we check
+that the terms it would produce are a subset of the pattern it sets.
+"""
+
+import argparse
+import os
+import re
+import sys
+from collections import OrderedDict
+
+# a single factor of a term, after the screened rate
+
+FACTOR = (r"(?:Y\(\w+\)|amrex::Math::powi<\d+>\(Y\(\w+\)\)|"
+          r"state\.rho|amrex::Math::powi<\d+>\(state\.rho\)|state\.y_e)")
+
+TERM = re.compile(r"([+-]?)\s*(?:(\d[\d.]*(?:[eE][+-]?\d+)?)\s*\*\s*)?"
+                  r"screened_rates\(\s*(k_\w+)\s*\)"
+                  r"((?:\s*\*\s*" + FACTOR + r")*)")
+
+
+def get_function_body(code, name):
+    """return the body of the function name in code"""
+
+    start = code.find(f"void {name}(")
+    if start < 0:
+        return None
+
+    brace = code.find("{", start)
+    depth = 0
+    for n in range(brace, len(code)):
+        if code[n] == "{":
+            depth += 1
+        elif code[n] == "}":
+            depth -= 1
+            if depth == 0:
+                return code[brace+1:n]
+
+    return None
+
+
+def parse_factors(factors):
+    """return the monomial of a term as (((species, power), ...),
+    rho power, y_e power)"""
+
+    abundances = OrderedDict()
+    rho_pow = 0
+    ye_pow = 0
+
+    for f in re.findall(FACTOR, factors):
+        m = re.fullmatch(r"Y\((\w+)\)", f)
+        if m:
+            abundances[m.group(1)] = abundances.get(m.group(1), 0) + 1
+            continue
+        m = re.fullmatch(r"amrex::Math::powi<(\d+)>\(Y\((\w+)\)\)", f)
+        if m:
+            abundances[m.group(2)] = abundances.get(m.group(2), 0) + int(m.group(1))
+            continue
+        if f == "state.rho":
+            rho_pow += 1
+            continue
+        m = re.fullmatch(r"amrex::Math::powi<(\d+)>\(state\.rho\)", f)
+        if m:
+            rho_pow += int(m.group(1))
+            continue
+        if f == "state.y_e":
+            ye_pow += 1
+            continue
+        raise ValueError(f"unknown factor {f}")
+
+    return tuple(sorted(abundances.items())), rho_pow, ye_pow
+
+
+def get_fluxes(code):
+    """parse rhs_nuc into a list of fluxes (rate, monomial) and the
+    stoichiometry {flux index: {species: coefficient}}"""
+
+    body = get_function_body(code, "rhs_nuc")
+    if body is None:
+        sys.exit("write_flux_network.py: ERROR: no rhs_nuc() found in actual_rhs.H")
+
+    fluxes = OrderedDict()
+    stoich = {}
+
+    for spec, expr in re.findall(r"ydot_nuc\(\s*(\w+)\s*\)\s*=(.*?);", body, re.S):
+
+        for m in TERM.finditer(expr):
+            sign, coeff, rate, factors = m.groups()
+
+            c = float(coeff) if coeff else 1.0
+            if sign == "-":
+                c = -c
+
+            # a minus sign in front of a group would flip all of the
+            # terms in it, which we do not handle
+
+            before = expr[:m.start()].rstrip()
+            if before.endswith("-("):
+                sys.exit(f"write_flux_network.py: ERROR: cannot parse the equation for {spec}")
+
+            key = (rate, parse_factors(factors))
+            if key not in fluxes:
+                fluxes[key] = len(fluxes)
+            f = fluxes[key]
+
+            stoich.setdefault(f, OrderedDict())
+            stoich[f][spec] = stoich[f].get(spec, 0.0) + c
+
+        # everything else must just be grouping or a zero
+
+        rest = TERM.sub("", expr)
+        rest = re.sub(r"0\.0(?:e0)?(?:_rt)?", "", rest)
+        if re.sub(r"[\s()+]", "", rest):
+            sys.exit(f"write_flux_network.py: ERROR: unable to parse the equation for {spec}: "
+                     f"{rest.strip()[:80]}")
+
+    # drop any species whose terms cancel
+
+    for f in stoich:
+        stoich[f] = OrderedDict((s, c) for s, c in stoich[f].items() if c != 0.0)
+
+    return list(fluxes), stoich
+
+
+def check_jacobian_pattern(code, fluxes, stoich):
+    """the flux Jacobian adds to (i, j) for every species i that a flux
+    changes and reactant j of the flux.  Make sure jac_nuc() sets all of
+    these, so the sparse Jacobian (which uses the pattern of jac_nuc())
+    stores them"""
+
+    body = get_function_body(code, "jac_nuc")
+    if body is None:
+        return
+
+    pattern = set(re.findall(r"jac\.(?:set|add)\s*\(\s*(\w+)\s*,\s*(\w+)\s*,", body))
+
+    for f, (_, (abundances, _, _)) in enumerate(fluxes):
+        for i in stoich[f]:
+            for j, _ in abundances:
+                if (i, j) not in pattern:
+                    sys.exit(f"write_flux_network.py: ERROR: the flux Jacobian has a term ({i}, {j}) "
+                             "that jac_nuc() does not set")
+
+
+def format_array(values, indent, per_line=8):
+    """format a list as the body of a C++ initializer"""
+    lines = []
+    for n in range(0, len(values), per_line):
+        lines.append(indent + ", ".join(str(v) for v in values[n:n+per_line]))
+    return ",\n".join(lines)
+
+
+def write_flux_network(fluxes, stoich, header_name):
+    """write the flux and stoichiometry tables"""
+
+    nflux = len(fluxes)
+    max_react = max(1, max(len(a) for _, (a, _, _) in fluxes))
+
+    flux_rate = []
+    flux_nreact = []
+    flux_react = []
+    flux_react_pow = []
+    flux_rho_pow = []
+    flux_ye_pow = []
+
+    for rate, (abundances, rho_pow, ye_pow) in fluxes:
+        flux_rate.append(f"Rates::{rate}")
+        flux_nreact.append(len(abundances))
+        flux_react += [f"Species::{s}" for s, _ in abundances] + ["0"] * (max_react - len(abundances))
+        flux_react_pow += [p for _, p in abundances] + [0] * (max_react - len(abundances))
+        flux_rho_pow.append(rho_pow)
+        flux_ye_pow.append(ye_pow)
+
+    max_rho_pow = max(flux_rho_pow)
+    max_ye_pow = max(flux_ye_pow)
+
+    stoich_ptr = [0]
+    stoich_spec = []
+    stoich_coef = []
+    for f in range(nflux):
+        for s, c in stoich[f].items():
+            stoich_spec.append(f"Species::{s}")
+            stoich_coef.append(f"{c!r}_rt")
+        stoich_ptr.append(len(stoich_spec))
+
+    indent = "        "
+
+    with open(header_name, "w") as f:
+        f.write("// Do not edit -- this is automatically generated by write_flux_network.py\n")
+        f.write("// at compile time\n\n")
+        f.write("#ifndef FLUX_NETWORK_H\n")
+        f.write("#define FLUX_NETWORK_H\n\n")
+        f.write("#include <AMReX_REAL.H>\n\n")
+        f.write("#include <actual_network.H>\n\n")
+        f.write("using namespace amrex::literals;\n\n")
+        f.write("namespace FluxTables\n{\n")
+        f.write("    // number of distinct fluxes (a rate times a product of abundances)\n")
+        f.write(f"    constexpr int nflux = {nflux};\n\n")
+        f.write("    // maximum number of distinct reactants in a flux\n")
+        f.write(f"    constexpr int max_react = {max_react};\n\n")
+        f.write("    // maximum powers of the density and Y_e in a flux\n")
+        f.write(f"    constexpr int max_rho_pow = {max_rho_pow};\n")
+        f.write(f"    constexpr int max_ye_pow = {max_ye_pow};\n\n")
+        f.write("    // number of (flux, species) stoichiometry entries\n")
+        f.write(f"    constexpr int nstoich = {len(stoich_spec)};\n\n")
+        f.write("    // the rate of each flux\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int flux_rate[nflux] = {\n")
+        f.write(format_array(flux_rate, indent, per_line=4) + "\n    };\n\n")
+        f.write("    // the reactants (1-based species) of each flux and their powers, for\n")
+        f.write("    // flux f these are the first flux_nreact[f] of\n")
+        f.write("    // flux_react[f*max_react:(f+1)*max_react]\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int flux_nreact[nflux] = {\n")
+        f.write(format_array(flux_nreact, indent, per_line=16) + "\n    };\n\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int flux_react[nflux*max_react] = {\n")
+        f.write(format_array(flux_react, indent, per_line=max_react * 2) + "\n    };\n\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int flux_react_pow[nflux*max_react] = {\n")
+        f.write(format_array(flux_react_pow, indent, per_line=max_react * 4) + "\n    };\n\n")
+        f.write("    // the powers of the density and Y_e in each flux\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int flux_rho_pow[nflux] = {\n")
+        f.write(format_array(flux_rho_pow, indent, per_line=16) + "\n    };\n\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int flux_ye_pow[nflux] = {\n")
+        f.write(format_array(flux_ye_pow, indent, per_line=16) + "\n    };\n\n")
+        f.write("    // flux f contributes stoich_coef[s] * flux to dY/dt of species\n")
+        f.write("    // stoich_spec[s] (1-based) for s in [stoich_ptr[f], stoich_ptr[f+1])\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int stoich_ptr[nflux+1] = {\n")
+        f.write(format_array(stoich_ptr, indent, per_line=16) + "\n    };\n\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int stoich_spec[nstoich] = {\n")
+        f.write(format_array(stoich_spec, indent, per_line=6) + "\n    };\n\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED amrex::Real stoich_coef[nstoich] = {\n")
+        f.write(format_array(stoich_coef, indent, per_line=6) + "\n    };\n")
+        f.write("}\n\n")
+        f.write("#endif\n")
+
+
+def check_flux_hooks(code):
+    """with USE_REACT_FLUX_RHS, the network's rhs_nuc() and jac_nuc()
+    need to call the flux_network versions.  pynucastro does not write
+    these calls, so a regenerated network would otherwise build and
+    quietly ignore the option"""
+
+    for name in ["rhs_nuc", "jac_nuc"]:
+        body = get_function_body(code, name)
+        if body is None or f"flux_network::{name}(" not in body:
+            sys.exit(f"write_flux_network.py: ERROR: USE_REACT_FLUX_RHS=TRUE, but {name}() in "
+                     f"actual_rhs.H does not call flux_network::{name}() -- was the network "
+                     "regenerated without the REACT_FLUX_RHS hooks?")
+
+
+def main():
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--microphysics_path", type=str, default="",
+                        help="path to Microphysics/")
+    parser.add_argument("--net", type=str, default="",
+                        help="name of the network")
+    parser.add_argument("--odir", type=str, default="",
+                        help="output directory")
+    parser.add_argument("--defines", type=str, default="",
+                        help="any preprocessor defines")
+
+    args = parser.parse_args()
+
+    rhs_file = os.path.join(args.microphysics_path, "networks", args.net, "actual_rhs.H")
+    with open(rhs_file) as f:
+        code = f.read()
+
+    if "-DREACT_FLUX_RHS" in args.defines.split():
+        check_flux_hooks(code)
+
+    fluxes, stoich = get_fluxes(code)
+    if not fluxes:
+        sys.exit("write_flux_network.py: ERROR: no reaction terms found in rhs_nuc()")
+
+    check_jacobian_pattern(code, fluxes, stoich)
+
+    write_flux_network(fluxes, stoich, os.path.join(args.odir, "flux_network.H"))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,454 @@
+#!/usr/bin/env python3
+
+"""Extract the nonzero pattern of the analytic Jacobian of a network
+and write it, together with a fill-reducing ordering and the symbolic
+LU factorization of the pattern, and a grouping of the columns for
+the numerical Jacobian, to jacobian_sparsity.H.
+
+The pattern is taken from the jac.set() / jac.add() calls in the
+network's actual_rhs.H (as written by pynucastro), augmented with the
+full energy row and column (d(edot)/dX and d(Xdot)/de) and the
+diagonal (needed for I - h J).
+
+The species are reordered using a minimum degree ordering of the
+symmetrized pattern, with the energy equation placed last since it
+couples to everything.  We then do a symbolic Gaussian elimination
+without pivoting on the reordered pattern, so the numerical
+factorization never needs to allocate storage for fill-in.
+
+Finally, the species columns are colored so that the columns in each
+group are structurally independent, allowing the numerical Jacobian
+to perturb a whole group at once.  The light particles (n, p, alpha)
+usually participate in almost every rate, so their rows are dense,
+and any two columns would conflict there.  Up to two of these rows are
+therefore left out of the coloring, and the numerical Jacobian instead
+recovers them from the conservation of baryon number and charge.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+from general_null import network_param_file
+
+
+def get_species(net_file, defines):
+    """return the names of the species enum for the network, in
+    order -- these match the names write_network.py creates"""
+
+    species = []
+    extra_species = []
+    aux_vars = []
+
+    err = network_param_file.parse(species, extra_species, aux_vars,
+                                   net_file, defines)
+    if err:
+        sys.exit("write_jacobian_sparsity.py: ERROR: unable to parse the network file")
+
+    return species
+
+
+def get_pattern(code, species):
+    """scan the network's Jacobian for the (row, column) pairs it sets.
+    The indices returned are 0-based, with the energy equation being
+    len(species)"""
+
+    spec_index = {name: n for n, name in enumerate(species)}
+
+    pattern = set()
+
+    for row, col in re.findall(r"jac\.(?:set|add)\s*\(\s*(\w+)\s*,\s*(\w+)\s*,", code):
+        if row in spec_index and col in spec_index:
+            pattern.add((spec_index[row], spec_index[col]))
+
+    if not pattern:
+        sys.exit("write_jacobian_sparsity.py: ERROR: no species Jacobian terms found in actual_rhs.H")
+
+    nspec = len(species)
+    ienuc = nspec
+
+    for n in range(nspec + 1):
+        pattern.add((n, n))
+        pattern.add((ienuc, n))
+        pattern.add((n, ienuc))
+
+    return pattern
+
+
+def get_charge_nonconserving_columns(code, species, charges):
+    """return the (0-based) species columns of the Jacobian that have
+    a contribution from a rate that does not conserve charge (the weak
+    rates).  We find these by balancing Z in the rate names, e.g.,
+    k_p_C12_to_N13 or k_Co56_to_Fe56.  Anything we cannot parse is
+    assumed to not conserve charge, which is always safe."""
+
+    spec_index = {name: n for n, name in enumerate(species)}
+
+    # Z of everything that can appear in a rate name
+
+    z = {"n": 0, "p": 1, "d": 1, "t": 1}
+    for name, charge in zip(species, charges):
+        z[name] = charge
+
+    # pieces of the name that describe the rate source, not a nucleus
+
+    labels = {"weak", "wc12", "wc07", "mo03", "ffn", "langanke", "derived",
+              "removed", "approx", "modified", "electron", "capture",
+              "bet", "pos", "neg"}
+
+    def conserves_charge(rate):
+        if "_to_" not in rate:
+            return False
+        reactants, products = rate[2:].split("_to_", 1)
+        balance = 0
+        for sign, side in [(1, reactants), (-1, products)]:
+            for token in side.split("_"):
+                if token in z:
+                    balance += sign * z[token]
+                elif token not in labels:
+                    return False
+        return balance == 0
+
+    columns = set()
+
+    for m in re.finditer(r"jac\.(?:set|add)\s*\(\s*(\w+)\s*,\s*(\w+)\s*,\s*(\w+)\s*\)", code):
+        row, col, value = m.groups()
+        if row not in spec_index or col not in spec_index:
+            continue
+
+        # the expression for this term is the last assignment to scratch
+
+        expr = None
+        if value == "scratch":
+            start = code.rfind("scratch =", 0, m.start())
+            if start >= 0:
+                expr = code[start:m.start()]
+
+        if expr is None:
+            columns.add(spec_index[col])
+            continue
+
+        for rate in re.findall(r"screened_rates\s*\(\s*(k_\w+)\s*\)", expr):
+            if not conserves_charge(rate):
+                columns.add(spec_index[col])
+                break
+
+    return columns
+
+
+def minimum_degree_ordering(nspec, pattern):
+    """order the species by repeatedly eliminating the node of the
+    symmetrized elimination graph with the fewest neighbors"""
+
+    adj = [set() for _ in range(nspec)]
+    for i, j in pattern:
+        if i != j and i < nspec and j < nspec:
+            adj[i].add(j)
+            adj[j].add(i)
+
+    order = []
+    remaining = set(range(nspec))
+
+    while remaining:
+        p = min(remaining, key=lambda k: (len(adj[k]), k))
+        order.append(p)
+        remaining.remove(p)
+
+        # eliminating p connects all of its neighbors to each other
+        nbrs = adj[p]
+        for n in nbrs:
+            adj[n].discard(p)
+            adj[n] |= nbrs - {n}
+        adj[p] = set()
+
+    return order
+
+
+def symbolic_lu(neqs, pattern):
+    """return the pattern of L + U for Gaussian elimination without
+    pivoting of a matrix with the given (already permuted) pattern"""
+
+    rows = [set() for _ in range(neqs)]
+    cols = [set() for _ in range(neqs)]
+    for i, j in pattern:
+        rows[i].add(j)
+        cols[j].add(i)
+
+    for k in range(neqs):
+        lower = [i for i in cols[k] if i > k]
+        upper = [j for j in rows[k] if j > k]
+        for i in lower:
+            for j in upper:
+                if j not in rows[i]:
+                    rows[i].add(j)
+                    cols[j].add(i)
+
+    return rows
+
+
+def color_columns(nspec, pattern, skip_rows=(), extra_row=()):
+    """group the species columns so that no two columns in a group
+    share a nonzero row (Curtis, Powell, & Reid 1974).  All of the
+    columns in a group can then be differenced with a single RHS
+    evaluation.  We use a greedy, largest-first coloring of the column
+    intersection graph.  Only the species rows and columns are
+    considered -- the energy row and column are handled separately.
+    The rows in skip_rows are ignored, and extra_row is the set of
+    columns of an additional row that must be respected.
+
+    Returns the color of each species column."""
+
+    col_rows = [set() for _ in range(nspec)]
+    for i, j in pattern:
+        if i < nspec and j < nspec and i not in skip_rows:
+            col_rows[j].add(i)
+    for j in extra_row:
+        col_rows[j].add(nspec)
+
+    order = sorted(range(nspec), key=lambda j: (-len(col_rows[j]), j))
+
+    color = [-1] * nspec
+    color_rows = []
+
+    for j in order:
+        for c, rows in enumerate(color_rows):
+            if not rows & col_rows[j]:
+                color[j] = c
+                rows |= col_rows[j]
+                break
+        else:
+            color[j] = len(color_rows)
+            color_rows.append(set(col_rows[j]))
+
+    return color
+
+
+def choose_dense_rows(species_info, pattern, weak_columns):
+    """pick the species rows to leave out of the coloring, and color
+    the remaining rows.  One row is recovered from baryon number
+    conservation, sum_i A_i dY_i/dt = 0, and a second from charge
+    conservation, which holds except for the weak rates, so the
+    charge nonconservation, sum_i Z_i dY_i/dt, becomes an extra
+    row.  The energy released by the weak rates (the tabulated
+    neutrino and gamma losses) is found the same way, so the extra
+    row is respected for every choice.  We keep whichever choice
+    gives the fewest groups."""
+
+    nspec = len(species_info)
+
+    row_degree = [0] * nspec
+    for i, j in pattern:
+        if i < nspec and j < nspec:
+            row_degree[i] += 1
+
+    densest = sorted(range(nspec), key=lambda i: (-row_degree[i], i))
+
+    options = [([], color_columns(nspec, pattern, extra_row=weak_columns))]
+
+    options.append((densest[:1], color_columns(nspec, pattern, skip_rows=densest[:1],
+                                               extra_row=weak_columns)))
+
+    # two rows are only recoverable if they have a different Z/A
+
+    d1, d2 = densest[:2]
+    if species_info[d1].Z * species_info[d2].A != species_info[d2].Z * species_info[d1].A:
+        options.append((densest[:2], color_columns(nspec, pattern, skip_rows=densest[:2],
+                                                   extra_row=weak_columns)))
+
+    return min(options, key=lambda opt: (max(opt[1]) + 1, len(opt[0])))
+
+
+def format_array(values, indent, per_line=16):
+    """format a list of integers as the body of a C++ initializer"""
+    lines = []
+    for n in range(0, len(values), per_line):
+        lines.append(indent + ", ".join(str(v) for v in values[n:n+per_line]))
+    return ",\n".join(lines)
+
+
+def write_sparsity(species_info, pattern, weak_columns, header_name):
+    """compute the ordering and fill-in and write the header"""
+
+    nspec = len(species_info)
+    neqs = nspec + 1
+
+    # perm[p] is the (0-based) equation that is p-th in the factorization
+
+    perm = minimum_degree_ordering(nspec, pattern) + [nspec]
+    iperm = [0] * neqs
+    for p, n in enumerate(perm):
+        iperm[n] = p
+
+    permuted = {(iperm[i], iperm[j]) for i, j in pattern}
+
+    rows = symbolic_lu(neqs, permuted)
+
+    row_ptr = [0]
+    col_idx = []
+    diag = []
+    for p in range(neqs):
+        for q in sorted(rows[p]):
+            if q == p:
+                diag.append(len(col_idx))
+            col_idx.append(q)
+        row_ptr.append(len(col_idx))
+
+    nnz = len(col_idx)
+
+    # map from the (unpermuted) dense index to the storage location
+
+    csr_index = [-1] * (neqs * neqs)
+    for p in range(neqs):
+        for s in range(row_ptr[p], row_ptr[p+1]):
+            i = perm[p]
+            j = perm[col_idx[s]]
+            csr_index[i * neqs + j] = s
+
+    # column groups for the numerical Jacobian, and the pattern of
+    # the remaining species rows by column (CSC) so we know which rows
+    # each column hits
+
+    dense_rows, color = choose_dense_rows(species_info, pattern, weak_columns)
+    num_colors = max(color) + 1
+
+    # the grouped difference misses the dependence of the screening on
+    # the full composition, so only use it if it saves at least a
+    # quarter of the RHS evaluations.  Otherwise, we write no groups,
+    # and the numerical Jacobian differences one species at a time.
+    # This happens when there are more than two dense rows (e.g. n, p,
+    # and He4 in sn160), since only two can be recovered.
+
+    use_groups = 4 * num_colors <= 3 * nspec
+    if not use_groups:
+        num_colors = 0
+        dense_rows = []
+
+    color_ptr = [0]
+    color_cols = []
+    for c in range(num_colors):
+        color_cols += [j + 1 for j in range(nspec) if color[j] == c]
+        color_ptr.append(len(color_cols))
+    if not use_groups:
+        color_cols = [j + 1 for j in range(nspec)]
+
+    spec_col_ptr = [0]
+    spec_row_idx = []
+    for j in range(nspec):
+        spec_row_idx += [i + 1 for i in range(nspec)
+                         if (i, j) in pattern and i not in dense_rows]
+        spec_col_ptr.append(len(spec_row_idx))
+
+    charge_nonconserving = [1 if j in weak_columns else 0 for j in range(nspec)]
+
+    indent = "        "
+
+    with open(header_name, "w") as f:
+        f.write("// Do not edit -- this is automatically generated by write_jacobian_sparsity.py\n")
+        f.write("// at compile time\n\n")
+        f.write("#ifndef JACOBIAN_SPARSITY_H\n")
+        f.write("#define JACOBIAN_SPARSITY_H\n\n")
+        f.write("#include <AMReX_REAL.H>\n")
+        f.write("#include <AMReX_Array.H>\n\n")
+        f.write("#include <network_properties.H>\n\n")
+        f.write("namespace JacSparsity\n{\n")
+        f.write("    // number of equations (species + energy)\n")
+        f.write(f"    constexpr int neqs = {neqs};\n\n")
+        f.write("    // number of entries set by the network's Jacobian\n")
+        f.write(f"    constexpr int nnz_jac = {len(pattern)};\n\n")
+        f.write("    // number of entries stored, including the fill-in from the LU\n")
+        f.write(f"    constexpr int nnz = {nnz};\n\n")
+        f.write("    // CSR structure of L + U in the permuted ordering\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int row_ptr[neqs+1] = {\n")
+        f.write(format_array(row_ptr, indent) + "\n    };\n\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int col_idx[nnz] = {\n")
+        f.write(format_array(col_idx, indent) + "\n    };\n\n")
+        f.write("    // location of the diagonal element of each permuted row\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int diag[neqs] = {\n")
+        f.write(format_array(diag, indent) + "\n    };\n\n")
+        f.write("    // perm[p] is the (0-based) equation eliminated p-th\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int perm[neqs] = {\n")
+        f.write(format_array(perm, indent) + "\n    };\n\n")
+        f.write("    // location of element (i, j) (0-based, unpermuted) at i * neqs + j,\n")
+        f.write("    // or -1 if it is structurally zero\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int csr_index[neqs*neqs] = {\n")
+        f.write(format_array(csr_index, indent) + "\n    };\n\n")
+        f.write("    // groups of species columns that do not share any nonzero row,\n")
+        f.write("    // for the column-colored numerical Jacobian.  The columns (1-based)\n")
+        f.write("    // of group c are color_cols[color_ptr[c]:color_ptr[c+1]].  If there\n")
+        f.write("    // are no groups, they would not save enough RHS evaluations, and the\n")
+        f.write("    // species are differenced one at a time\n")
+        f.write(f"    constexpr int num_colors = {num_colors};\n\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int color_ptr[num_colors+1] = {\n")
+        f.write(format_array(color_ptr, indent) + "\n    };\n\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int color_cols[NumSpec] = {\n")
+        f.write(format_array(color_cols, indent) + "\n    };\n\n")
+        f.write("    // the dense species rows (1-based) that are not in the groups above\n")
+        f.write("    // and are instead found from baryon number (and charge) conservation\n")
+        f.write(f"    constexpr int num_dense_rows = {len(dense_rows)};\n\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int dense_rows[2] = {\n")
+        f.write(format_array([i + 1 for i in dense_rows] + [0] * (2 - len(dense_rows)), indent) + "\n    };\n\n")
+        f.write("    // whether species column j (0-based) has a contribution from a rate that\n")
+        f.write("    // does not conserve charge -- at most one of these is in each group\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int charge_nonconserving[NumSpec] = {\n")
+        f.write(format_array(charge_nonconserving, indent) + "\n    };\n\n")
+        f.write("    // the other species rows (1-based) set in species column j (1-based) are\n")
+        f.write("    // spec_row_idx[spec_col_ptr[j-1]:spec_col_ptr[j]]\n")
+        f.write(f"    constexpr int nnz_spec = {len(spec_row_idx)};\n\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int spec_col_ptr[NumSpec+1] = {\n")
+        f.write(format_array(spec_col_ptr, indent) + "\n    };\n\n")
+        f.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int spec_row_idx[nnz_spec] = {\n")
+        f.write(format_array(spec_row_idx, indent) + "\n    };\n")
+        f.write("}\n\n")
+        f.write("#endif\n")
+
+
+def main():
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--microphysics_path", type=str, default="",
+                        help="path to Microphysics/")
+    parser.add_argument("--net", type=str, default="",
+                        help="name of the network")
+    parser.add_argument("--odir", type=str, default="",
+                        help="output directory")
+    parser.add_argument("--defines", type=str, default="",
+                        help="any preprocessor defines")
+
+    args = parser.parse_args()
+
+    micro_path = args.microphysics_path
+    net = args.net
+
+    net_file = os.path.join(micro_path, "networks", net, f"{net}.net")
+    if not os.path.isfile(net_file):
+        net_file = os.path.join(micro_path, "networks", net, "pynucastro.net")
+
+    net_header = os.path.join(micro_path, "networks", net, "actual_network.H")
+    with open(net_header) as f:
+        if "#define NEW_NETWORK_IMPLEMENTATION" in f.read():
+            sys.exit("write_jacobian_sparsity.py: ERROR: the sparse Jacobian is not supported "
+                     "for NEW_NETWORK_IMPLEMENTATION networks (they use RHS::dgefa)")
+
+    rhs_file = os.path.join(micro_path, "networks", net, "actual_rhs.H")
+    with open(rhs_file) as f:
+        code = f.read()
+
+    species_info = get_species(net_file, args.defines)
+    species = [spec.short_name.capitalize() for spec in species_info]
+
+    pattern = get_pattern(code, species)
+    weak_columns = get_charge_nonconserving_columns(code, species,
+                                                    [spec.Z for spec in species_info])
+
+    try:
+        os.makedirs(args.odir)
+    except FileExistsError:
+        pass
+
+    write_sparsity(species_info, pattern, weak_columns,
+                   os.path.join(args.odir, "jacobian_sparsity.H"))
+
+
+if __name__ == "__main__":
+    main()
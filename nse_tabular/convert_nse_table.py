@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+
+"""Convert the text NSE table into the binary format that init_nse()
+can read with a single read (see nse_table_data.H for the layout).
+
+usage: convert_nse_table.py nse_aprox19.tbl nse_aprox19.bin
+"""
+
+import argparse
+import struct
+
+import numpy as np
+
+# these must match nse_table_data.H
+
+TABLE_MAGIC = b"NSETAB\0\0"
+TABLE_VERSION = 1
+TABLE_BYTE_ORDER = 0x01020304
+NTHERMO = 6
+
+HEADER_FORMAT = "=8s6i6d"
+
+
+def read_text_table(text_name):
+    """return the table as a 2-d array, one row per table point, with
+    the 3 grid columns first"""
+
+    # the header is 4 lines
+    return np.loadtxt(text_name, skiprows=4, ndmin=2)
+
+
+def get_grid(data):
+    """find the rho, T, and Ye grids from the table data.  rho varies
+    the slowest, then T, and Ye varies the fastest (from high to low).
+    The first 3 columns are the grid, but we identify which is which
+    by how fast they vary, to not rely on their order."""
+
+    grid = data[:, 0:3]
+    nchanges = [np.count_nonzero(np.diff(grid[:, i])) for i in range(3)]
+    irho, it, iye = np.argsort(nchanges)
+
+    # the text table is written with a limited precision
+    logrhos = np.unique(np.round(grid[:, irho], 8))
+    logTs = np.unique(np.round(grid[:, it], 8))
+    yes = np.unique(np.round(grid[:, iye], 8))
+
+    if len(logrhos) * len(logTs) * len(yes) != data.shape[0]:
+        raise ValueError("the table is not a complete rho, T, Ye grid")
+
+    return logrhos, logTs, yes
+
+
+def write_binary_table(text_name, binary_name):
+    """read the text table text_name and write the binary version to
+    binary_name"""
+
+    data = read_text_table(text_name)
+    logrhos, logTs, yes = get_grid(data)
+
+    nvars = data.shape[1] - 3
+    if nvars <= NTHERMO:
+        raise ValueError("the table has no mass fraction columns")
+
+    header = struct.pack(HEADER_FORMAT,
+                         TABLE_MAGIC, TABLE_VERSION, TABLE_BYTE_ORDER,
+                         len(logTs), len(logrhos), len(yes), nvars,
+                         logTs.min(), (logTs.max() - logTs.min()) / (len(logTs) - 1),
+                         logrhos.min(), (logrhos.max() - logrhos.min()) / (len(logrhos) - 1),
+                         yes.max(), (yes.max() - yes.min()) / (len(yes) - 1))
+
+    # the rows are already in the order of nse_idx(), so each column
+    # is written out contiguously
+
+    with open(binary_name, "wb") as f:
+        f.write(header)
+        np.ascontiguousarray(data[:, 3:].T, dtype="=f8").tofile(f)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("text_table", help="the text NSE table to read")
+    parser.add_argument("binary_table", help="the binary NSE table to write")
+    args = parser.parse_args()
+
+    write_binary_table(args.text_table, args.binary_table)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+
+"""Compare the final state of two burn_cell runs of the same problem
+to within a tolerance, e.g. a run with integrator.use_warm_start = 1
+against the stored output of the same run without it.  Unlike diff,
+this allows for the differences at the level of the integration
+tolerances that we expect when the integrator takes different steps.
+
+usage: compare_burn_cell.py reference.out test.out [--rtol R] [--atol A]
+"""
+
+import argparse
+import sys
+
+
+def parse(filename):
+    """return the final T, the energy added, the final mass fractions,
+    and the number of steps from burn_cell's output"""
+
+    T = None
+    added_e = None
+    n_steps = None
+    X = {}
+
+    with open(filename) as f:
+        lines = f.readlines()
+
+    in_X = False
+    for line in lines:
+        if line.startswith("new mass fractions"):
+            in_X = True
+            continue
+        if in_X:
+            if line.startswith("---"):
+                in_X = False
+                continue
+            name, value = line.split()
+            X[name] = float(value)
+            continue
+
+        if line.startswith(" - final T ="):
+            T = float(line.split("=")[1])
+        elif line.startswith(" - added e ="):
+            added_e = float(line.split("=")[1])
+        elif line.startswith("number of steps taken:"):
+            n_steps = int(line.split(":")[1])
+
+    if T is None or added_e is None or not X:
+        sys.exit(f"could not find the final state in {filename}")
+
+    return T, added_e, X, n_steps
+
+
+def main():
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("reference", type=str)
+    parser.add_argument("test", type=str)
+    parser.add_argument("--rtol", type=float, default=1.e-3,
+                        help="relative tolerance on T, the energy added, and X")
+    parser.add_argument("--atol", type=float, default=1.e-4,
+                        help="absolute tolerance on X")
+
+    args = parser.parse_args()
+
+    T_ref, e_ref, X_ref, steps_ref = parse(args.reference)
+    T, e, X, steps = parse(args.test)
+
+    failed = False
+
+    def check(name, ref, val, atol=0.0):
+        nonlocal failed
+        ok = abs(val - ref) <= args.rtol * max(abs(ref), abs(val)) + atol
+        if not ok:
+            failed = True
+        print(f"{name:>8} {ref:20.10g} {val:20.10g} {'' if ok else '<-- differs'}")
+
+    check("T", T_ref, T)
+    check("added e", e_ref, e)
+
+    if set(X) != set(X_ref):
+        sys.exit("the two runs have different species")
+
+    for name in X_ref:
+        check(name, X_ref[name], X[name], args.atol)
+
+    print(f"number of steps (reference, test): {steps_ref} {steps}")
+
+    if failed:
+        sys.exit("the final states differ by more than the tolerance")
+
+    print("the final states agree")
+
+
+if __name__ == "__main__":
+    main()
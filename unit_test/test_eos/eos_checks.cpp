@@ -0,0 +1,10 @@
+#include <AMReX_MultiFab.H>
+
+#include <test_eos.H>
+
+// There are no checks specific to this EOS (see
+// helmholtz_checks.cpp for the Helmholtz EOS).
+
+void eos_checks (const amrex::MultiFab& /*state*/, const plot_t& /*vars*/)
+{
+}
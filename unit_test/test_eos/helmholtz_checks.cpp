@@ -0,0 +1,176 @@
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_Print.H>
+#include <AMReX_Reduce.H>
+
+#include <network.H>
+#include <eos.H>
+#include <test_eos.H>
+#include <variables.H>
+
+#include <cmath>
+#include <limits>
+#include <string>
+
+using namespace amrex;
+
+// Checks of the optional paths of the Helmholtz EOS.  Each compares
+// to the standard path over the zones of the test.
+
+namespace
+{
+    // an EOS state that records the number of table evaluations
+
+    struct eos_iter_t : eos_extra_t
+    {
+        int n_iter{};
+    };
+
+    AMREX_GPU_HOST_DEVICE AMREX_INLINE
+    Real rel_diff (Real a, Real b)
+    {
+        return std::abs(a - b) / amrex::max(std::abs(b), std::numeric_limits<Real>::min());
+    }
+
+    // With eos.helm_table_blocked = 1, eos_test_C() used the
+    // cell-blocked table.  Evaluate the EOS again with the standard
+    // interpolation and report the largest relative difference in
+    // the thermodynamic quantities and their derivatives.
+
+    void check_blocked_table (const MultiFab& state, const plot_t& vars)
+    {
+        if (helmholtz::cells == nullptr) {
+            return;
+        }
+
+        amrex::Gpu::streamSynchronize();
+
+        Real* cells_save = helmholtz::cells;
+        helmholtz::cells = nullptr;
+
+        ReduceOps<ReduceOpMax> reduce_op;
+        ReduceData<Real> reduce_data(reduce_op);
+        using ReduceTuple = typename decltype(reduce_data)::Type;
+
+        for (MFIter mfi(state); mfi.isValid(); ++mfi) {
+            const Box& bx = mfi.validbox();
+            auto const sp = state.const_array(mfi);
+
+            reduce_op.eval(bx, reduce_data,
+            [=] AMREX_GPU_DEVICE (int i, int j, int k) -> ReduceTuple
+            {
+                eos_extra_t eos_state;
+                eos_state.rho = sp(i, j, k, vars.irho);
+                eos_state.T = sp(i, j, k, vars.itemp);
+                for (int n = 0; n < NumSpec; n++) {
+                    eos_state.xn[n] = sp(i, j, k, vars.ispec+n);
+                }
+
+                eos(eos_input_rt, eos_state);
+
+                Real diff = rel_diff(sp(i, j, k, vars.ip), eos_state.p);
+                diff = amrex::max(diff, rel_diff(sp(i, j, k, vars.ie), eos_state.e));
+                diff = amrex::max(diff, rel_diff(sp(i, j, k, vars.is), eos_state.s));
+                diff = amrex::max(diff, rel_diff(sp(i, j, k, vars.idpdt), eos_state.dpdT));
+                diff = amrex::max(diff, rel_diff(sp(i, j, k, vars.idpdr), eos_state.dpdr));
+                diff = amrex::max(diff, rel_diff(sp(i, j, k, vars.idedt), eos_state.dedT));
+                diff = amrex::max(diff, rel_diff(sp(i, j, k, vars.idedr), eos_state.dedr));
+                diff = amrex::max(diff, rel_diff(sp(i, j, k, vars.ine), eos_state.xne));
+
+                return {diff};
+            });
+        }
+
+        Real max_diff = amrex::get<0>(reduce_data.value(reduce_op));
+        ParallelDescriptor::ReduceRealMax(max_diff);
+
+        helmholtz::cells = cells_save;
+
+        amrex::Print() << "cell-blocked table: maximum relative difference from the standard interpolation = "
+                       << max_diff << std::endl;
+    }
+
+    // With eos.use_eos_inverse_tables = 1, the Newton iterations of
+    // the (rho, e) and (rho, p) inversions start from the inverse
+    // tables.  Starting from T = 100 K, as eos_test_C() does, report
+    // the number of table evaluations per call (including the final
+    // one at the converged state) with and without the tables, and
+    // the largest error in the inverted T.
+
+    void check_inverse_tables (const MultiFab& state, const plot_t& vars)
+    {
+        if (! helmholtz::inverse::ready) {
+            return;
+        }
+
+        amrex::Gpu::streamSynchronize();
+
+        const eos_input_t inputs[2] = {eos_input_re, eos_input_rp};
+        const std::string input_names[2] = {"eos_input_re", "eos_input_rp"};
+
+        const Long n_zones = state.boxArray().numPts();
+
+        for (int m = 0; m < 2; ++m) {
+
+            const eos_input_t input = inputs[m];
+
+            for (int use_tables = 1; use_tables >= 0; --use_tables) {
+
+                helmholtz::inverse::ready = use_tables;
+
+                ReduceOps<ReduceOpSum, ReduceOpMax, ReduceOpMax> reduce_op;
+                ReduceData<Real, int, Real> reduce_data(reduce_op);
+                using ReduceTuple = typename decltype(reduce_data)::Type;
+
+                for (MFIter mfi(state); mfi.isValid(); ++mfi) {
+                    const Box& bx = mfi.validbox();
+                    auto const sp = state.const_array(mfi);
+
+                    reduce_op.eval(bx, reduce_data,
+                    [=] AMREX_GPU_DEVICE (int i, int j, int k) -> ReduceTuple
+                    {
+                        eos_iter_t eos_state;
+                        eos_state.rho = sp(i, j, k, vars.irho);
+                        eos_state.e = sp(i, j, k, vars.ie);
+                        eos_state.p = sp(i, j, k, vars.ip);
+                        for (int n = 0; n < NumSpec; n++) {
+                            eos_state.xn[n] = sp(i, j, k, vars.ispec+n);
+                        }
+
+                        eos_state.T = 100.0_rt;
+
+                        eos(input, eos_state);
+
+                        const Real temp_zone = sp(i, j, k, vars.itemp);
+
+                        return {static_cast<Real>(eos_state.n_iter), eos_state.n_iter,
+                                std::abs(eos_state.T - temp_zone) / temp_zone};
+                    });
+                }
+
+                auto hv = reduce_data.value(reduce_op);
+                Real sum_iter = amrex::get<0>(hv);
+                int max_iter = amrex::get<1>(hv);
+                Real max_err = amrex::get<2>(hv);
+
+                ParallelDescriptor::ReduceRealSum(sum_iter);
+                ParallelDescriptor::ReduceIntMax(max_iter);
+                ParallelDescriptor::ReduceRealMax(max_err);
+
+                amrex::Print() << input_names[m]
+                               << (use_tables ? " with the inverse tables: " : " without the inverse tables: ")
+                               << "mean table evaluations = " << sum_iter / static_cast<Real>(n_zones)
+                               << ", max = " << max_iter
+                               << ", maximum relative error in T = " << max_err << std::endl;
+            }
+        }
+
+        helmholtz::inverse::ready = 1;
+    }
+}
+
+void eos_checks (const MultiFab& state, const plot_t& vars)
+{
+    check_blocked_table(state, vars);
+    check_inverse_tables(state, vars);
+}
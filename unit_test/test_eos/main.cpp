@@ -14,6 +14,7 @@ using namespace amrex;
 
 #include <network.H>
 #include <eos.H>
+#include <eos_multifab.H>
 #include <variables.H>
 
 #include <cmath>
@@ -141,6 +142,47 @@ void main_main ()
 
     }
 
+    eos_checks(state, vars);
+
+    // Invert e for T again, over the whole MultiFab at once with the
+    // bulk interface.  The mass fractions stay at the end so they
+    // can be copied in one go.
+
+    MultiFab bulk(ba, dm, 3 + NumSpec, Nghost);
+
+    eos_comp_t comp;
+    comp.rho = 0;
+    comp.T = 1;
+    comp.e = 2;
+    comp.xn = 3;
+
+    MultiFab::Copy(bulk, state, vars.irho, comp.rho, 1, 0);
+    MultiFab::Copy(bulk, state, vars.ie, comp.e, 1, 0);
+    MultiFab::Copy(bulk, state, vars.ispec, comp.xn, NumSpec, 0);
+
+    // reset T to give it some work to do
+    bulk.setVal(100.0, comp.T, 1);
+
+    eos_bulk(eos_input_re, bulk, comp);
+
+    for ( MFIter mfi(state); mfi.isValid(); ++mfi )
+    {
+        const Box& bx = mfi.validbox();
+
+        Array4<Real> const sp = state.array(mfi);
+        Array4<Real const> const bp = bulk.const_array(mfi);
+
+        const int itemp = vars.itemp;
+        const int ierr = vars.ierr_T_eos_re_bulk;
+        const int iT = comp.T;
+
+        amrex::ParallelFor(bx,
+        [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
+        {
+            sp(i, j, k, ierr) = std::abs(bp(i, j, k, iT) - sp(i, j, k, itemp)) / sp(i, j, k, itemp);
+        });
+    }
+
     // Call the timer again and compute the maximum difference between
     // the start time and stop time over all processors
     Real stop_time = ParallelDescriptor::second() - strt_time;
@@ -17,6 +17,7 @@ plot_t init_variables() {
   p.ierr_rho_eos_tp = p.next_index(1);
   p.ierr_T_eos_rp = p.next_index(1);
   p.ierr_T_eos_re = p.next_index(1);
+  p.ierr_T_eos_re_bulk = p.next_index(1);
   p.ierr_rho_eos_ps = p.next_index(1);
   p.ierr_T_eos_ps = p.next_index(1);
   p.ierr_rho_eos_ph = p.next_index(1);
@@ -77,6 +78,7 @@ void get_varnames(const plot_t& p, amrex::Vector<std::string>& names) {
   names[p.ierr_rho_eos_tp] = "err_rho_eos_tp";
   names[p.ierr_T_eos_rp] = "err_T_eos_rp";
   names[p.ierr_T_eos_re] = "err_T_eos_re";
+  names[p.ierr_T_eos_re_bulk] = "err_T_eos_re_bulk";
   names[p.ierr_rho_eos_ps] = "err_rho_eos_ps";
   names[p.ierr_T_eos_ps] = "err_T_eos_ps";
   names[p.ierr_rho_eos_ph] = "err_rho_eos_ph";
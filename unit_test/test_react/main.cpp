@@ -18,6 +18,8 @@ using namespace amrex;
 #include <variables.H>
 #include <unit_test.H>
 #include <react_util.H>
+#include <burn_scheduler.H>
+#include <burn_retry_queue.H>
 
 int main (int argc, char* argv[])
 {
@@ -34,6 +36,7 @@ void main_main ()
 
     // AMREX_SPACEDIM: number of dimensions
     int n_cell, max_grid_size, print_every_nrhs;
+    int use_burn_scheduler;
 
     std::string prefix = "plt";
 
@@ -61,6 +64,11 @@ void main_main ()
 
         pp.query("prefix", prefix);
 
+        // hand the zones out to the threads by their cost, instead
+        // of burning them box by box
+        use_burn_scheduler = 0;
+        pp.query("use_burn_scheduler", use_burn_scheduler);
+
     }
 
     Vector<int> is_periodic(AMREX_SPACEDIM,0);
@@ -193,6 +201,149 @@ void main_main ()
 
     ValLocPair<int, burn_t> r;
 
+#ifndef AMREX_USE_GPU
+    // with integrator.defer_burn_retry, the zones that failed, to be
+    // burned again at the end
+
+    burn_retry_queue_t<burn_t> retry_queue;
+    auto* retry_queue_p = &retry_queue;
+#endif
+
+#ifndef AMREX_USE_GPU
+    if (use_burn_scheduler) {
+        BL_PROFILE("do_react");
+
+        // the scheduler stores the cost of each zone (n_rhs) in
+        // component 0 of integrator_n_rhs.  In a simulation, this is
+        // the cost from the previous step -- here, we get it by first
+        // burning a copy of the state.
+
+        integrator_n_rhs.setVal(0);
+
+        auto const& ia = integrator_n_rhs.arrays();
+
+        {
+            MultiFab state_seed(ba, dm, vars.n_plot_comps, Nghost);
+            MultiFab::Copy(state_seed, state, 0, 0, vars.n_plot_comps, Nghost);
+
+            auto const& ma_seed = state_seed.arrays();
+
+            burn_scheduled(state_seed, integrator_n_rhs,
+            [=] (int box_no, int i, int j, int k) -> int
+            {
+                auto n_rhs = ia[box_no];
+
+                burn_t burn_state;
+                do_react(i, j, k, ma_seed[box_no], burn_state, n_rhs, vars);
+
+                return n_rhs(i,j,k,0);
+            });
+        }
+
+        auto const& ma = state.arrays();
+
+#ifdef _OPENMP
+        const int n_threads = omp_get_max_threads();
+#else
+        const int n_threads = 1;
+#endif
+
+        // the zone with the most RHS calls, per thread
+
+        Vector<ValLocPair<int, burn_t>> r_thread(n_threads);
+        for (auto& rt : r_thread) {
+            rt.value = std::numeric_limits<int>::lowest();
+        }
+
+        // the estimated cost of each zone, in the order each thread
+        // burned them
+
+        Vector<Vector<int>> cost_thread(n_threads);
+
+        auto stats = burn_scheduled(state, integrator_n_rhs,
+        [=, &r_thread, &cost_thread] (int box_no, int i, int j, int k) -> int
+        {
+            Array4<Real> const& s = ma[box_no];
+            auto n_rhs = ia[box_no];
+
+#ifdef _OPENMP
+            cost_thread[omp_get_thread_num()].push_back(n_rhs(i,j,k,0));
+#else
+            cost_thread[0].push_back(n_rhs(i,j,k,0));
+#endif
+
+            burn_t burn_state;
+            bool success = do_react(i, j, k, s, burn_state, n_rhs, vars);
+
+            if (!success) {
+                if (integrator_rp::defer_burn_retry) {
+                    burn_t burn_in;
+                    react_input(i, j, k, s, burn_in, vars);
+                    retry_queue_p->push(box_no, i, j, k, tmax, burn_in);
+                } else {
+                    Gpu::Atomic::Add(num_failed_d, 1);
+                }
+            }
+
+#ifdef _OPENMP
+            auto& rt = r_thread[omp_get_thread_num()];
+#else
+            auto& rt = r_thread[0];
+#endif
+            if (n_rhs(i,j,k,0) > rt.value) {
+                rt = ValLocPair<int, burn_t>{n_rhs(i,j,k,0), burn_state};
+            }
+
+            return n_rhs(i,j,k,0);
+        });
+
+        r = r_thread[0];
+        for (const auto& rt : r_thread) {
+            if (rt.value > r.value) {
+                r = rt;
+            }
+        }
+
+        amrex::Print() << "burn scheduler: " << stats.n_zones << " zones on "
+                       << stats.n_threads << " threads, " << stats.n_stolen << " stolen" << std::endl;
+        amrex::Print() << "burn scheduler: load imbalance (max / avg thread time) = "
+                       << stats.load_imbalance << std::endl;
+
+        // each thread works through its own queue most expensive
+        // first, so its estimated costs can only go up when it takes
+        // a zone from another thread's queue
+
+        int n_increase = 0;
+        int cost_min = std::numeric_limits<int>::max();
+        int cost_max = 0;
+
+        for (const auto& ct : cost_thread) {
+            for (int n = 0; n < static_cast<int>(ct.size()); ++n) {
+                if (n > 0 && ct[n] > ct[n-1]) {
+                    n_increase++;
+                }
+                cost_min = amrex::min(cost_min, ct[n]);
+                cost_max = amrex::max(cost_max, ct[n]);
+            }
+        }
+
+        amrex::Print() << "burn scheduler: estimated cost from " << cost_min
+                       << " to " << cost_max << " RHS evaluations" << std::endl;
+
+        if (n_increase > stats.n_stolen) {
+            amrex::Error("burn scheduler: the zones were not burned most expensive first");
+        }
+
+        if (stats.n_threads == 1 && stats.n_stolen > 0) {
+            amrex::Error("burn scheduler: zones were stolen with only one thread");
+        }
+
+        if (stats.n_stolen > stats.n_zones) {
+            amrex::Error("burn scheduler: more zones were stolen than there are zones");
+        }
+
+    } else
+#endif
     {
         BL_PROFILE("do_react");
 
@@ -211,6 +362,14 @@ void main_main ()
             bool success = do_react(i, j, k, s, burn_state, n_rhs, vars);
 
             if (!success) {
+#ifndef AMREX_USE_GPU
+                if (integrator_rp::defer_burn_retry) {
+                    burn_t burn_in;
+                    react_input(i, j, k, s, burn_in, vars);
+                    retry_queue_p->push(box_no, i, j, k, tmax, burn_in);
+                    return {ValLocPair<int, burn_t>{n_rhs(i,j,k,0), burn_state}};
+                }
+#endif
                 Gpu::Atomic::Add(num_failed_d, 1);
             }
 
@@ -222,6 +381,28 @@ void main_main ()
     aa_num_failed.copyToHost(&num_failed, 1);
     Gpu::synchronize();
 
+#ifndef AMREX_USE_GPU
+    // now burn the zones that failed again, with the retry parameters
+
+    if (!retry_queue.empty()) {
+        BL_PROFILE("do_react_retry");
+
+        auto const& ma = state.arrays();
+        auto const& ia = integrator_n_rhs.arrays();
+
+        const int n_retry = retry_queue.size();
+
+        num_failed += retry_failed_burns(retry_queue,
+        [=] (const burn_retry_t<burn_t>& zone, const burn_t& burn_state)
+        {
+            react_output(zone.i, zone.j, zone.k, ma[zone.box_no], burn_state,
+                         ia[zone.box_no], vars);
+        });
+
+        amrex::Print() << "retried " << n_retry << " failed burns" << std::endl;
+    }
+#endif
+
     if (num_failed > 0) {
         amrex::Abort("Integration failed");
     }
@@ -280,6 +461,20 @@ void main_main ()
         std::cout << "avg number of steps: " << n_step_sum / n_cell_cubed << std::endl;
         std::cout << "max number of steps: " << n_step_max << std::endl;
 
+#if !defined(AMREX_USE_GPU) && !defined(SDC)
+        if (integrator_rp::use_burn_cache) {
+            // these are just for this rank
+            auto cache_stats = burn_cache_stats();
+            std::cout << "burn cache: " << cache_stats.n_query << " queries, "
+                      << cache_stats.n_retrieve << " retrieved, "
+                      << cache_stats.n_grow << " grown, "
+                      << cache_stats.n_add << " added, "
+                      << cache_stats.n_evict << " evicted" << std::endl;
+            std::cout << "burn cache: " << cache_stats.n_records << " records ("
+                      << cache_stats.memory / 1024 << " kB)" << std::endl;
+        }
+#endif
+
     }
 
     // output the state that took the most time